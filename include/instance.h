@@ -0,0 +1,38 @@
+/*
+ * inits - A lightweight UNIX init system
+ * Copyright (C) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef INSTANCE_H
+#define INSTANCE_H
+
+#include "service.h"
+
+/**
+ * Determine how many instances a templated service expands to
+ * Returns the instance count (at least 1), or -1 on failure
+ */
+int instance_total(const service_info_t *service);
+
+/**
+ * Prepare the current (child) process to run a service instance
+ * Exports INITS_INSTANCE and INITS_INSTANCES, and for pinned templates
+ * restricts the CPU affinity and exports INITS_CPU or INITS_NODE
+ * Returns 0 on success, -1 on failure
+ */
+int instance_setup(const service_info_t *service);
+
+#endif /* INSTANCE_H */
@@ -23,7 +23,8 @@
 
 /**
  * Initialize the logging system
- * Opens the log file at /var/log/inits.log
+ * Maps the binary ring log named by $INITS_LOG_RING if set,
+ * otherwise opens the log file at $INITS_LOG_FILE or /var/log/inits.log
  * Returns 0 on success, -1 on failure
  */
 int init_logging(void);
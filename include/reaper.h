@@ -0,0 +1,66 @@
+/*
+ * inits - A lightweight UNIX init system
+ * Copyright (C) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef REAPER_H
+#define REAPER_H
+
+/**
+ * Initialize process tracking for the given runlevel
+ * Marks inits as a child subreaper (Linux) so that orphaned descendants
+ * of service scripts are reparented to inits instead of PID 1
+ * Returns 0 on success, -1 on failure
+ */
+int reaper_init(int runlevel);
+
+/**
+ * Release all process tracking resources
+ */
+void reaper_cleanup(void);
+
+/**
+ * Record a freshly forked service process
+ * pid: PID of the forked service script
+ * service_name: Name of the service the process belongs to
+ * Returns 0 on success, -1 on failure
+ */
+int reaper_track(int pid, const char *service_name);
+
+/**
+ * Wait for a tracked service process to complete
+ * Reaps any other descendants that exit in the meantime and charges
+ * their resource usage to the service that spawned them
+ * Returns 0 on success, -1 on failure
+ */
+int reaper_wait(int pid, int *status);
+
+/**
+ * Reap descendants for up to the given number of seconds
+ * Used in place of sleep() while waiting for processes to terminate
+ * Returns early when running as PID 1 and no processes are left
+ */
+void reaper_drain(unsigned int seconds);
+
+/**
+ * Write per-service resource usage as a Prometheus textfile
+ * Uses $INITS_METRICS_FILE if set, otherwise INITS_METRICS_FILE;
+ * an empty path disables the export
+ * Returns 0 on success, -1 on failure
+ */
+int reaper_export_metrics(void);
+
+#endif /* REAPER_H */
@@ -0,0 +1,147 @@
+/*
+ * inits - A lightweight UNIX init system
+ * Copyright (C) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef RINGLOG_H
+#define RINGLOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef RINGLOG_DEFAULT_PATH
+#define RINGLOG_DEFAULT_PATH "/var/log/inits.ring"
+#endif
+#define RINGLOG_DEFAULT_SIZE (1024 * 1024)
+#define RINGLOG_MAGIC 0x474f4c52u      /* "RLOG" */
+#define RINGLOG_VERSION 1
+#define RINGLOG_RECORD_SIZE 128
+#define RINGLOG_PAYLOAD_SIZE (RINGLOG_RECORD_SIZE - 32)
+
+/**
+ * Event types stored in ring records
+ */
+typedef enum {
+    RINGLOG_EVENT_MESSAGE = 0,    /* Free-form log_message() text */
+    RINGLOG_EVENT_OPEN = 1,       /* Writer attached; payload is wall-clock time */
+    RINGLOG_EVENT_SERVICE_START = 2,    /* Payload is the service name */
+    RINGLOG_EVENT_SERVICE_COMPLETE = 3  /* Payload is the service name */
+} ringlog_event_t;
+
+/**
+ * Severity levels, matching the "[LEVEL]" tags of the text log
+ */
+typedef enum {
+    RINGLOG_LEVEL_INFO = 0,
+    RINGLOG_LEVEL_WARN = 1,
+    RINGLOG_LEVEL_ERROR = 2,
+    RINGLOG_LEVEL_FATAL = 3
+} ringlog_level_t;
+
+/**
+ * File header, occupying the first record slot of the ring file
+ */
+typedef struct {
+    uint32_t magic;               /* RINGLOG_MAGIC */
+    uint32_t version;             /* RINGLOG_VERSION */
+    uint32_t record_size;         /* RINGLOG_RECORD_SIZE */
+    uint32_t record_count;        /* Number of record slots after the header */
+    uint64_t next_seq;            /* Sequence number of the next record (from 1) */
+    uint8_t reserved[RINGLOG_RECORD_SIZE - 24];
+} ringlog_header_t;
+
+/**
+ * One fixed-size log record
+ * Record seq is stored in slot (seq - 1) % record_count; a slot whose seq
+ * is 0 is being written
+ */
+typedef struct {
+    uint64_t seq;                 /* Sequence number, written last */
+    uint64_t timestamp_ns;        /* CLOCK_MONOTONIC time of the event */
+    uint32_t service_id;          /* ringlog_service_id() of the service, 0 if none */
+    int32_t status;               /* Exit status (SERVICE_COMPLETE only) */
+    uint8_t level;                /* ringlog_level_t */
+    uint8_t event;                /* ringlog_event_t */
+    uint16_t length;              /* Payload bytes used (not NUL-terminated) */
+    uint32_t reserved;
+    char payload[RINGLOG_PAYLOAD_SIZE];
+} ringlog_record_t;
+
+/**
+ * An open, memory-mapped ring file
+ */
+typedef struct {
+    ringlog_header_t *header;     /* Mapped header */
+    ringlog_record_t *records;    /* Mapped record slots */
+    size_t map_size;              /* Size of the mapping */
+} ringlog_t;
+
+/**
+ * Map a ring file
+ * Writers create or reinitialize the file with room for size bytes if it
+ * does not hold a valid ring; readers map an existing file read-only
+ * Returns 0 on success, -1 on failure
+ */
+int ringlog_open(ringlog_t *ring, const char *path, size_t size, int writable);
+
+/**
+ * Unmap a ring file
+ */
+void ringlog_close(ringlog_t *ring);
+
+/**
+ * Append a record, overwriting the oldest one when the ring is full
+ * Payloads longer than RINGLOG_PAYLOAD_SIZE are truncated
+ * Safe to call from several processes sharing the mapping
+ */
+void ringlog_write(ringlog_t *ring, int level, int event, uint32_t service_id,
+                   int32_t status, const char *payload, size_t length);
+
+/**
+ * Sequence number of the next record to be written
+ */
+uint64_t ringlog_next_seq(const ringlog_t *ring);
+
+/**
+ * Sequence number of the oldest record still held by the ring
+ */
+uint64_t ringlog_oldest_seq(const ringlog_t *ring);
+
+/**
+ * Copy record seq out of the ring
+ * Returns 1 if the record was read, 0 if it is still being written,
+ * -1 if it has already been overwritten
+ */
+int ringlog_read(const ringlog_t *ring, uint64_t seq, ringlog_record_t *record);
+
+/**
+ * Compute the service ID stored in records for a service name
+ * Never returns 0, which marks records not tied to a service
+ */
+uint32_t ringlog_service_id(const char *name);
+
+/**
+ * Name of a level ("INFO", "WARN", ...)
+ */
+const char *ringlog_level_name(int level);
+
+/**
+ * Parse a level name
+ * Returns the level on success, -1 if the name is unknown
+ */
+int ringlog_parse_level(const char *name, size_t length);
+
+#endif /* RINGLOG_H */
@@ -21,6 +21,37 @@
 
 #include <stddef.h>
 
+/**
+ * How a templated service ("name@...") is expanded into instances
+ */
+typedef enum {
+    INSTANCE_NONE,                /* Not a template */
+    INSTANCE_FIXED,               /* "name@N": fixed number of instances */
+    INSTANCE_CPUS,                /* "name@": one per online CPU */
+    INSTANCE_CPU_PINNED,          /* "name@cpu": one per CPU, pinned to it */
+    INSTANCE_NODE_PINNED          /* "name@node": one per NUMA node, pinned to it */
+} instance_mode_t;
+
+#define MAX_TRIGGERS 4
+
+/**
+ * Conditions that can activate a lazily started service
+ */
+typedef enum {
+    TRIGGER_EXISTS,               /* Path exists */
+    TRIGGER_NONEMPTY,             /* Directory has at least one entry */
+    TRIGGER_MODIFIED              /* File is created or modified after boot */
+} trigger_type_t;
+
+/**
+ * One activation trigger, declared in the script as
+ * "# inits: trigger <exists|nonempty|modified> <path>"
+ */
+typedef struct {
+    trigger_type_t type;          /* Condition to wait for */
+    char path[256];               /* Watched path */
+} service_trigger_t;
+
 /**
  * Information about a single service script
  */
@@ -30,6 +61,11 @@ typedef struct {
     char ordering_prefix[64];     /* Alphabetical ordering characters */
     int runlevel;                 /* Runlevel this entry applies to */
     char full_path[512];          /* Full path to script */
+    instance_mode_t instance_mode; /* Template expansion mode */
+    int instance_count;           /* Number of instances (INSTANCE_FIXED) */
+    int instance;                 /* Instance index, -1 if not an instance */
+    service_trigger_t triggers[MAX_TRIGGERS]; /* Activation triggers */
+    int trigger_count;            /* Number of triggers, 0 to start normally */
 } service_info_t;
 
 /**
@@ -43,13 +79,15 @@ typedef struct {
 
 /**
  * Discover all service scripts for the given runlevel
- * Scans /etc/inits.d directory and filters by runlevel
+ * Scans $INITS_DIR (default /etc/inits.d) and filters by runlevel
  * Returns 0 on success, -1 on failure
  */
 int discover_services(int runlevel, service_list_t *services);
 
 /**
  * Parse a service filename to extract runlevel and ordering information
+ * Recognizes templated names ("3d-worker@", "3d-worker@4", "3d-worker@cpu",
+ * "3d-worker@node"), which discover_services() expands into instances
  * Returns 1 if the service matches the given runlevel, 0 otherwise, -1 on error
  */
 int parse_service_filename(const char *filename, int runlevel, service_info_t *info);
@@ -74,6 +112,7 @@ int execute_service(const service_info_t *service);
 /**
  * Wait for a service to complete
  * Waits for the child process to finish and captures exit status
+ * Descendants reparented to inits are reaped and accounted meanwhile
  * Returns 0 on success, -1 on failure
  */
 int wait_for_service(int pid, int *exit_status);
@@ -81,7 +120,8 @@ int wait_for_service(int pid, int *exit_status);
 /**
  * Perform system shutdown sequence
  * Sends SIGTERM to all processes, waits 10 seconds,
- * then sends SIGKILL to remaining processes, waits 15 seconds
+ * then sends SIGKILL to remaining processes, waits 15 seconds,
+ * then syncs and unmounts all filesystems
  * Returns 0 on success, -1 on failure
  */
 int shutdown_system(void);
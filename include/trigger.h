@@ -0,0 +1,46 @@
+/*
+ * inits - A lightweight UNIX init system
+ * Copyright (C) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRIGGER_H
+#define TRIGGER_H
+
+#include "service.h"
+#include <signal.h>
+
+/**
+ * Start watching the activation triggers of all services that have them
+ * Records the current state of "modified" trigger paths as the baseline
+ * Returns the number of services waiting for a trigger, or -1 on failure
+ */
+long trigger_arm(const service_list_t *services);
+
+/**
+ * Wait until a trigger of a pending service fires
+ * Instances of a template fire together; the index of the first one is
+ * returned and all of them stop being pending
+ * Returns the service index, or -1 once nothing is pending, on failure,
+ * or when *stop becomes non-zero
+ */
+long trigger_wait(const service_list_t *services, volatile sig_atomic_t *stop);
+
+/**
+ * Stop watching and release trigger resources
+ */
+void trigger_cleanup(void);
+
+#endif /* TRIGGER_H */
@@ -0,0 +1,33 @@
+/*
+ * inits - A lightweight UNIX init system
+ * Copyright (C) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef UNMOUNT_H
+#define UNMOUNT_H
+
+/**
+ * Sync and unmount all filesystems at the end of shutdown
+ * Reads /proc/self/mountinfo, then syncs and unmounts each independent
+ * subtree below / in its own worker process, deepest mounts first.
+ * Filesystems that refuse to unmount are remounted read-only, and the
+ * root filesystem is synced and remounted read-only last. Workers still
+ * running after deadline_seconds are abandoned.
+ * Returns 0 if every filesystem was unmounted or made read-only, -1 otherwise
+ */
+int unmount_filesystems(unsigned int deadline_seconds);
+
+#endif /* UNMOUNT_H */
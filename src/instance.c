@@ -0,0 +1,211 @@
+/*
+ * inits - A lightweight UNIX init system
+ * Copyright (C) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE /* sched_setaffinity() and CPU_SET() */
+
+#include "instance.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#define NODE_ONLINE_PATH "/sys/devices/system/node/online"
+#define NODE_CPULIST_PATH "/sys/devices/system/node/node%d/cpulist"
+#define MAX_IDS 1024
+
+#ifdef __linux__
+/**
+ * Read a kernel ID list such as "0-3,8,10-11" from a sysfs file
+ * Returns the number of IDs stored, or -1 if the file cannot be read
+ */
+static int read_id_list(const char *path, int *ids, int max) {
+    FILE *file = fopen(path, "r");
+    int count = 0;
+    int first, last;
+
+    if (file == NULL) {
+        return -1;
+    }
+
+    while (count < max && fscanf(file, "%d", &first) == 1) {
+        int c = fgetc(file);
+
+        last = first;
+        if (c == '-') {
+            if (fscanf(file, "%d", &last) != 1) {
+                break;
+            }
+            c = fgetc(file);
+        }
+
+        for (int id = first; id <= last && count < max; id++) {
+            ids[count++] = id;
+        }
+
+        if (c != ',') {
+            break;
+        }
+    }
+
+    fclose(file);
+    return count;
+}
+#endif
+
+/**
+ * List the CPUs inits is allowed to run on, in ascending order
+ * Returns the number of CPUs (at least 1)
+ */
+static int available_cpus(int *cpus, int max) {
+    long online;
+
+#ifdef __linux__
+    cpu_set_t set;
+
+    /* Honour cpusets and taskset restrictions on inits itself */
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        int count = 0;
+        for (int cpu = 0; cpu < CPU_SETSIZE && count < max; cpu++) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus[count++] = cpu;
+            }
+        }
+        if (count > 0) {
+            return count;
+        }
+    }
+#endif
+
+    online = sysconf(_SC_NPROCESSORS_ONLN);
+    if (online < 1) {
+        online = 1;
+    } else if (online > max) {
+        online = max;
+    }
+
+    for (int i = 0; i < online; i++) {
+        cpus[i] = i;
+    }
+    return (int)online;
+}
+
+/**
+ * List the online NUMA nodes
+ * Returns the number of nodes (at least 1)
+ */
+static int numa_nodes(int *nodes, int max) {
+    int count = -1;
+
+#ifdef __linux__
+    count = read_id_list(NODE_ONLINE_PATH, nodes, max);
+#else
+    (void)max;
+#endif
+
+    /* Machines without NUMA support behave as a single node */
+    if (count < 1) {
+        nodes[0] = 0;
+        count = 1;
+    }
+    return count;
+}
+
+/**
+ * Restrict the calling process to the given CPUs
+ * Returns 0 on success, -1 on failure or if pinning is unsupported
+ */
+static int pin_to_cpus(const int *cpus, int count) {
+#ifdef __linux__
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    for (int i = 0; i < count; i++) {
+        if (cpus[i] >= 0 && cpus[i] < CPU_SETSIZE) {
+            CPU_SET(cpus[i], &set);
+        }
+    }
+    return sched_setaffinity(0, sizeof(set), &set);
+#else
+    (void)cpus;
+    (void)count;
+    return -1;
+#endif
+}
+
+int instance_total(const service_info_t *service) {
+    int ids[MAX_IDS];
+
+    switch (service->instance_mode) {
+    case INSTANCE_FIXED:
+        return service->instance_count;
+    case INSTANCE_CPUS:
+    case INSTANCE_CPU_PINNED:
+        return available_cpus(ids, MAX_IDS);
+    case INSTANCE_NODE_PINNED:
+        return numa_nodes(ids, MAX_IDS);
+    default:
+        return 1;
+    }
+}
+
+int instance_setup(const service_info_t *service) {
+    int ids[MAX_IDS];
+    char value[16];
+    int count;
+
+    snprintf(value, sizeof(value), "%d", service->instance);
+    setenv("INITS_INSTANCE", value, 1);
+    snprintf(value, sizeof(value), "%d", service->instance_count);
+    setenv("INITS_INSTANCES", value, 1);
+
+    if (service->instance_mode == INSTANCE_CPU_PINNED) {
+        count = available_cpus(ids, MAX_IDS);
+        int cpu = ids[service->instance % count];
+
+        snprintf(value, sizeof(value), "%d", cpu);
+        setenv("INITS_CPU", value, 1);
+        return pin_to_cpus(&cpu, 1);
+    }
+
+    if (service->instance_mode == INSTANCE_NODE_PINNED) {
+        char path[64];
+
+        count = numa_nodes(ids, MAX_IDS);
+        int node = ids[service->instance % count];
+
+        snprintf(value, sizeof(value), "%d", node);
+        setenv("INITS_NODE", value, 1);
+
+#ifdef __linux__
+        snprintf(path, sizeof(path), NODE_CPULIST_PATH, node);
+        count = read_id_list(path, ids, MAX_IDS);
+#else
+        (void)path;
+        count = -1;
+#endif
+        if (count < 1) {
+            return -1;
+        }
+        return pin_to_cpus(ids, count);
+    }
+
+    return 0;
+}
@@ -19,15 +19,23 @@
 #define _POSIX_C_SOURCE 200809L
 
 #include "logging.h"
+#include "ringlog.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdarg.h>
 #include <time.h>
 #include <string.h>
 
+#ifndef LOG_FILE_PATH
 #define LOG_FILE_PATH "/var/log/inits.log"
+#endif
 
 static FILE *log_file = NULL;
 
+/* Binary ring backend, enabled by setting INITS_LOG_RING */
+static ringlog_t ring;
+static int ring_enabled = 0;
+
 /**
  * Get current timestamp in format [YYYY-MM-DD HH:MM:SS]
  * Returns pointer to static buffer
@@ -44,11 +52,58 @@ static const char *get_timestamp(void) {
     return timestamp;
 }
 
+/**
+ * Get the text log path, honouring the INITS_LOG_FILE override
+ */
+static const char *log_file_path(void) {
+    const char *path = getenv("INITS_LOG_FILE");
+    return (path != NULL && path[0] != '\0') ? path : LOG_FILE_PATH;
+}
+
+/**
+ * Map the binary ring log named by INITS_LOG_RING, if any
+ * Returns 0 if the ring backend is in use, -1 otherwise
+ */
+static int init_ring_logging(void) {
+    const char *path = getenv("INITS_LOG_RING");
+    const char *size_str = getenv("INITS_LOG_RING_SIZE");
+    size_t size = RINGLOG_DEFAULT_SIZE;
+    char opened[32];
+    time_t now;
+    
+    if (path == NULL || path[0] == '\0') {
+        return -1;
+    }
+    
+    if (size_str != NULL && atol(size_str) > 0) {
+        size = (size_t)atol(size_str);
+    }
+    
+    if (ringlog_open(&ring, path, size, 1) < 0) {
+        fprintf(stderr, "%s [ERROR] Failed to map ring log %s, falling back to %s\n",
+                get_timestamp(), path, log_file_path());
+        return -1;
+    }
+    
+    /* Anchor the monotonic record timestamps to wall-clock time */
+    time(&now);
+    strftime(opened, sizeof(opened), "%Y-%m-%d %H:%M:%S", localtime(&now));
+    ringlog_write(&ring, RINGLOG_LEVEL_INFO, RINGLOG_EVENT_OPEN, 0, 0,
+                  opened, strlen(opened));
+    
+    ring_enabled = 1;
+    return 0;
+}
+
 int init_logging(void) {
-    log_file = fopen(LOG_FILE_PATH, "a");
+    if (init_ring_logging() == 0) {
+        return 0;
+    }
+    
+    log_file = fopen(log_file_path(), "a");
     if (log_file == NULL) {
         fprintf(stderr, "%s [ERROR] Failed to open log file %s, falling back to stderr\n",
-                get_timestamp(), LOG_FILE_PATH);
+                get_timestamp(), log_file_path());
         return -1;
     }
     
@@ -59,16 +114,60 @@ int init_logging(void) {
 }
 
 void close_logging(void) {
+    if (ring_enabled) {
+        ringlog_close(&ring);
+        ring_enabled = 0;
+    }
+    
     if (log_file != NULL) {
         fclose(log_file);
         log_file = NULL;
     }
 }
 
+/**
+ * Store a formatted message in the ring log
+ * A leading "[LEVEL] " tag is turned into the record level
+ */
+static void ring_message(const char *format, va_list args) {
+    char text[RINGLOG_PAYLOAD_SIZE + 32];
+    const char *body = text;
+    int level = RINGLOG_LEVEL_INFO;
+    int length;
+    
+    length = vsnprintf(text, sizeof(text), format, args);
+    if (length < 0) {
+        return;
+    }
+    if ((size_t)length >= sizeof(text)) {
+        length = sizeof(text) - 1;
+    }
+    
+    if (text[0] == '[') {
+        const char *end = strchr(text, ']');
+        int parsed = end != NULL ? ringlog_parse_level(text + 1, end - text - 1) : -1;
+        
+        if (parsed >= 0) {
+            level = parsed;
+            body = end[1] == ' ' ? end + 2 : end + 1;
+        }
+    }
+    
+    ringlog_write(&ring, level, RINGLOG_EVENT_MESSAGE, 0, 0,
+                  body, (size_t)length - (size_t)(body - text));
+}
+
 void log_message(const char *format, ...) {
     va_list args;
     FILE *output = log_file != NULL ? log_file : stderr;
     
+    if (ring_enabled) {
+        va_start(args, format);
+        ring_message(format, args);
+        va_end(args);
+        return;
+    }
+    
     /* Write timestamp */
     fprintf(output, "%s ", get_timestamp());
     
@@ -85,10 +184,24 @@ void log_message(const char *format, ...) {
 }
 
 void log_service_start(const char *service_name) {
+    if (ring_enabled) {
+        ringlog_write(&ring, RINGLOG_LEVEL_INFO, RINGLOG_EVENT_SERVICE_START,
+                      ringlog_service_id(service_name), 0,
+                      service_name, strlen(service_name));
+        return;
+    }
+    
     log_message("[INFO] Starting service: %s", service_name);
 }
 
 void log_service_complete(const char *service_name, int exit_status) {
+    if (ring_enabled) {
+        ringlog_write(&ring, exit_status == 0 ? RINGLOG_LEVEL_INFO : RINGLOG_LEVEL_ERROR,
+                      RINGLOG_EVENT_SERVICE_COMPLETE, ringlog_service_id(service_name),
+                      exit_status, service_name, strlen(service_name));
+        return;
+    }
+    
     if (exit_status == 0) {
         log_message("[INFO] Service completed successfully: %s (exit status: %d)",
                    service_name, exit_status);
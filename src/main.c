@@ -20,6 +20,8 @@
 
 #include "logging.h"
 #include "service.h"
+#include "reaper.h"
+#include "trigger.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -117,6 +119,9 @@ static int init_system(void) {
     /* Initialize logging system */
     init_logging();
     
+    /* Track service process trees and their resource usage */
+    reaper_init(runlevel);
+    
     /* Set up signal handlers for graceful shutdown */
     if (setup_signal_handlers() < 0) {
         log_message("[ERROR] Failed to set up signal handlers");
@@ -129,6 +134,101 @@ static int init_system(void) {
     return runlevel;
 }
 
+/**
+ * Run a group of services to completion
+ * All services in the group are launched before any is waited for, so
+ * the instances of a template run concurrently; a group of one service
+ * behaves like plain sequential execution
+ */
+static void run_services(service_info_t *group, size_t count) {
+    int *pids = malloc(count * sizeof(int));
+    
+    if (pids == NULL) {
+        log_message("[ERROR] Failed to allocate memory for service group");
+        return;
+    }
+    
+    /* Launch every service in the group */
+    for (size_t i = 0; i < count; i++) {
+        pids[i] = execute_service(&group[i]);
+        if (pids[i] < 0) {
+            /* Log error but continue with next service */
+            log_message("[ERROR] Failed to execute service %s", group[i].name);
+        }
+    }
+    
+    /* Wait for each of them to complete */
+    for (size_t i = 0; i < count; i++) {
+        int exit_status;
+        
+        if (pids[i] < 0) {
+            continue;
+        }
+        
+        if (wait_for_service(pids[i], &exit_status) < 0) {
+            /* Log error but continue with next service */
+            log_message("[ERROR] Failed to wait for service %s", group[i].name);
+            continue;
+        }
+        
+        /* Log service completion with exit status */
+        log_service_complete(group[i].name, exit_status);
+    }
+    
+    free(pids);
+}
+
+/**
+ * Count the services starting at index i that form one launch group
+ * Instances of a template are adjacent after sorting and run together
+ */
+static size_t group_size(const service_list_t *services, size_t i) {
+    size_t count = 1;
+    
+    if (services->services[i].instance >= 0) {
+        while (i + count < services->count &&
+               services->services[i + count].instance >= 0 &&
+               strcmp(services->services[i + count].filename,
+                      services->services[i].filename) == 0) {
+            count++;
+        }
+    }
+    
+    return count;
+}
+
+/**
+ * Wait for the activation triggers of deferred services and run each
+ * service once its trigger fires, until none are left or shutdown is
+ * requested
+ */
+static void run_triggered_services(int runlevel, service_list_t *services) {
+    long pending;
+    long index;
+    
+    pending = trigger_arm(services);
+    if (pending <= 0) {
+        return;
+    }
+    
+    /* Nothing may hold up a halt or reboot */
+    if (runlevel == 0 || runlevel == 6) {
+        log_message("[WARN] Skipping %ld triggered service(s) in runlevel %d",
+                   pending, runlevel);
+        trigger_cleanup();
+        return;
+    }
+    
+    log_message("[INFO] Waiting for triggers of %ld service(s)", pending);
+    
+    while ((index = trigger_wait(services, &shutdown_requested)) >= 0) {
+        run_services(&services->services[index], group_size(services, (size_t)index));
+        reaper_export_metrics();
+    }
+    
+    trigger_cleanup();
+}
+
 /**
  * Main entry point
  */
@@ -152,10 +252,8 @@ int main(void) {
     }
     
     /* Execute all discovered services in order */
-    for (size_t i = 0; i < services.count; i++) {
-        service_info_t *service = &services.services[i];
-        int pid;
-        int exit_status;
+    for (size_t i = 0; i < services.count; ) {
+        size_t count = group_size(&services, i);
         
         /* Check if shutdown was requested via signal */
         if (shutdown_requested) {
@@ -163,26 +261,23 @@ int main(void) {
             break;
         }
         
-        /* Execute the service */
-        pid = execute_service(service);
-        if (pid < 0) {
-            /* Log error but continue with next service */
-            log_message("[ERROR] Failed to execute service %s", service->name);
-            continue;
-        }
-        
-        /* Wait for the service to complete */
-        if (wait_for_service(pid, &exit_status) < 0) {
-            /* Log error but continue with next service */
-            log_message("[ERROR] Failed to wait for service %s", service->name);
-            continue;
+        /* Services with activation triggers are started lazily below */
+        if (services.services[i].trigger_count > 0) {
+            log_message("[INFO] Deferring service %s until triggered",
+                       services.services[i].name);
+        } else {
+            run_services(&services.services[i], count);
         }
-        
-        /* Log service completion with exit status */
-        log_service_complete(service->name, exit_status);
+        i += count;
     }
     
     log_message("[INFO] Runlevel %d initialization complete", runlevel);
+    reaper_export_metrics();
+    
+    /* Start triggered services as their conditions are met */
+    if (!shutdown_requested) {
+        run_triggered_services(runlevel, &services);
+    }
     
     /* Perform shutdown sequence for runlevels 0 and 6 */
     if (runlevel == 0 || runlevel == 6) {
@@ -204,6 +299,7 @@ int main(void) {
     
     /* Clean up resources */
     free_service_list(&services);
+    reaper_cleanup();
     close_logging();
     
     return exit_code;
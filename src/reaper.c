@@ -0,0 +1,484 @@
+/*
+ * inits - A lightweight UNIX init system
+ * Copyright (C) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE /* wait4() and struct rusage fields */
+
+#include "reaper.h"
+#include "logging.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+#ifndef INITS_METRICS_FILE
+#define INITS_METRICS_FILE "/var/lib/node_exporter/textfile_collector/inits.prom"
+#endif
+#define INITIAL_CAPACITY 16
+#define DRAIN_INTERVAL_NS 100000000L /* 100ms between reap attempts */
+#define UNKNOWN_SERVICE "unknown"
+
+/**
+ * Accumulated resource usage of one service process tree
+ */
+typedef struct {
+    char name[256];               /* Service name */
+    struct timeval utime;         /* User CPU time */
+    struct timeval stime;         /* System CPU time */
+    long maxrss;                  /* Largest resident set seen (KiB) */
+    long minflt;                  /* Minor page faults */
+    long majflt;                  /* Major page faults */
+    long nvcsw;                   /* Voluntary context switches */
+    long nivcsw;                  /* Involuntary context switches */
+    unsigned long processes;      /* Number of processes reaped */
+    double wall_seconds;          /* Time the service script itself ran */
+} service_usage_t;
+
+/**
+ * A live (or reaped but not yet collected) descendant of inits
+ */
+typedef struct {
+    pid_t pid;                    /* Process ID */
+    size_t service;               /* Index into usage table */
+    int is_main;                  /* Service script waited for by inits */
+    int reaped;                   /* Main process exited, status pending */
+    int status;                   /* Raw wait status once reaped */
+    struct timespec started;      /* Fork time of main process */
+} tracked_process_t;
+
+static service_usage_t *usage = NULL;
+static size_t usage_count = 0;
+static size_t usage_capacity = 0;
+
+static tracked_process_t *processes = NULL;
+static size_t process_count = 0;
+static size_t process_capacity = 0;
+
+/* Service charged for orphans whose origin can no longer be determined */
+static size_t last_service = 0;
+static int current_runlevel = -1;
+
+/**
+ * Grow a dynamic array to hold at least one more element
+ */
+static int reserve(void **array, size_t *capacity, size_t count, size_t size) {
+    if (count >= *capacity) {
+        size_t new_capacity = *capacity ? *capacity * 2 : INITIAL_CAPACITY;
+        void *new_array = realloc(*array, new_capacity * size);
+        if (new_array == NULL) {
+            log_message("[ERROR] Failed to expand process tracking table");
+            return -1;
+        }
+        *array = new_array;
+        *capacity = new_capacity;
+    }
+    return 0;
+}
+
+/**
+ * Find the usage slot for a service, creating it if needed
+ * Returns the slot index on success, -1 on failure
+ */
+static long find_usage(const char *service_name) {
+    for (size_t i = 0; i < usage_count; i++) {
+        if (strcmp(usage[i].name, service_name) == 0) {
+            return (long)i;
+        }
+    }
+
+    if (reserve((void **)&usage, &usage_capacity, usage_count, sizeof(*usage)) < 0) {
+        return -1;
+    }
+
+    memset(&usage[usage_count], 0, sizeof(*usage));
+    strncpy(usage[usage_count].name, service_name, sizeof(usage[usage_count].name) - 1);
+    return (long)usage_count++;
+}
+
+/**
+ * Find a tracked process by PID
+ * Returns the table index, or -1 if the process is not tracked
+ */
+static long find_process(pid_t pid) {
+    for (size_t i = 0; i < process_count; i++) {
+        if (processes[i].pid == pid) {
+            return (long)i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Add a process to the tracking table
+ */
+static int add_process(pid_t pid, size_t service, int is_main) {
+    tracked_process_t *entry;
+
+    if (reserve((void **)&processes, &process_capacity, process_count,
+                sizeof(*processes)) < 0) {
+        return -1;
+    }
+
+    entry = &processes[process_count++];
+    memset(entry, 0, sizeof(*entry));
+    entry->pid = pid;
+    entry->service = service;
+    entry->is_main = is_main;
+    clock_gettime(CLOCK_MONOTONIC, &entry->started);
+    return 0;
+}
+
+/**
+ * Remove a process from the tracking table (order is not preserved)
+ */
+static void remove_process(size_t index) {
+    processes[index] = processes[--process_count];
+}
+
+/**
+ * Add a timeval to an accumulator
+ */
+static void add_timeval(struct timeval *total, const struct timeval *delta) {
+    total->tv_sec += delta->tv_sec;
+    total->tv_usec += delta->tv_usec;
+    if (total->tv_usec >= 1000000) {
+        total->tv_sec++;
+        total->tv_usec -= 1000000;
+    }
+}
+
+/**
+ * Attribute every untracked descendant below parent to a service
+ * Children of tracked processes inherit their parent's service, while
+ * untracked children are charged to default_service. Reads the Linux
+ * /proc/<pid>/task/<pid>/children lists; a no-op elsewhere.
+ */
+static void adopt_descendants(pid_t parent, size_t default_service) {
+#ifdef __linux__
+    char path[64];
+    FILE *children;
+    int child;
+
+    snprintf(path, sizeof(path), "/proc/%d/task/%d/children", (int)parent, (int)parent);
+    children = fopen(path, "r");
+    if (children == NULL) {
+        return;
+    }
+
+    while (fscanf(children, "%d", &child) == 1) {
+        long index = find_process(child);
+        size_t service = index >= 0 ? processes[index].service : default_service;
+
+        if (index < 0 && add_process(child, service, 0) < 0) {
+            break;
+        }
+        adopt_descendants(child, service);
+    }
+
+    fclose(children);
+#else
+    (void)parent;
+    (void)default_service;
+#endif
+}
+
+/**
+ * Charge a reaped process to its service and record main process status
+ */
+static void account_process(pid_t pid, int status, const struct rusage *ru) {
+    long index = find_process(pid);
+    service_usage_t *service;
+
+    if (index < 0) {
+        /* Exited before we ever saw it: charge the most recent service */
+        if (usage_count == 0 && find_usage(UNKNOWN_SERVICE) < 0) {
+            return;
+        }
+        service = &usage[last_service < usage_count ? last_service : 0];
+    } else {
+        service = &usage[processes[index].service];
+    }
+
+    add_timeval(&service->utime, &ru->ru_utime);
+    add_timeval(&service->stime, &ru->ru_stime);
+    if (ru->ru_maxrss > service->maxrss) {
+        service->maxrss = ru->ru_maxrss;
+    }
+    service->minflt += ru->ru_minflt;
+    service->majflt += ru->ru_majflt;
+    service->nvcsw += ru->ru_nvcsw;
+    service->nivcsw += ru->ru_nivcsw;
+    service->processes++;
+
+    if (index < 0) {
+        return;
+    }
+
+    if (processes[index].is_main) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        service->wall_seconds += (double)(now.tv_sec - processes[index].started.tv_sec) +
+                                 (double)(now.tv_nsec - processes[index].started.tv_nsec) / 1e9;
+        processes[index].reaped = 1;
+        processes[index].status = status;
+    } else {
+        remove_process((size_t)index);
+    }
+}
+
+int reaper_init(int runlevel) {
+    current_runlevel = runlevel;
+
+#ifdef __linux__
+    /* Orphaned daemons of double-forking scripts are reparented to us */
+    if (prctl(PR_SET_CHILD_SUBREAPER, 1, 0, 0, 0) < 0) {
+        log_message("[WARN] Failed to become child subreaper, "
+                    "daemon processes will not be tracked");
+        return -1;
+    }
+#endif
+
+    return 0;
+}
+
+void reaper_cleanup(void) {
+    free(processes);
+    processes = NULL;
+    process_count = 0;
+    process_capacity = 0;
+
+    free(usage);
+    usage = NULL;
+    usage_count = 0;
+    usage_capacity = 0;
+}
+
+int reaper_track(int pid, const char *service_name) {
+    long service = find_usage(service_name);
+
+    if (service < 0) {
+        return -1;
+    }
+
+    last_service = (size_t)service;
+    return add_process(pid, (size_t)service, 1);
+}
+
+int reaper_wait(int pid, int *status) {
+    for (;;) {
+        long index = find_process(pid);
+        struct rusage ru;
+        int child_status;
+        pid_t result;
+
+        if (index >= 0 && processes[index].reaped) {
+            size_t service = processes[index].service;
+
+            *status = processes[index].status;
+            remove_process((size_t)index);
+
+            /* Anything the script left behind now belongs to us */
+            adopt_descendants(getpid(), service);
+            return 0;
+        }
+
+        result = wait4(-1, &child_status, 0, &ru);
+        if (result < 0) {
+            return -1;
+        }
+
+        account_process(result, child_status, &ru);
+
+        /* Untracked PIDs (e.g. forked outside execute_service) */
+        if (index < 0 && result == pid) {
+            *status = child_status;
+            return 0;
+        }
+    }
+}
+
+void reaper_drain(unsigned int seconds) {
+    struct timespec now, deadline;
+    const struct timespec interval = { 0, DRAIN_INTERVAL_NS };
+
+    /* Resolve service ownership while the process tree is still intact */
+    adopt_descendants(getpid(), last_service);
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += seconds;
+
+    for (;;) {
+        struct rusage ru;
+        int child_status;
+        pid_t result = wait4(-1, &child_status, WNOHANG, &ru);
+
+        if (result > 0) {
+            account_process(result, child_status, &ru);
+            continue;
+        }
+
+        /* As PID 1 (e.g. of a PID namespace) every process is our descendant */
+        if (result < 0 && errno == ECHILD && getpid() == 1) {
+            log_message("[INFO] No processes left, ending wait early");
+            break;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (now.tv_sec > deadline.tv_sec ||
+            (now.tv_sec == deadline.tv_sec && now.tv_nsec >= deadline.tv_nsec)) {
+            break;
+        }
+        nanosleep(&interval, NULL);
+    }
+}
+
+/**
+ * Metric families exported per service
+ */
+typedef enum {
+    METRIC_CPU_USER,
+    METRIC_CPU_SYSTEM,
+    METRIC_WALL,
+    METRIC_MAX_RSS,
+    METRIC_MINOR_FAULTS,
+    METRIC_MAJOR_FAULTS,
+    METRIC_VOLUNTARY_SWITCHES,
+    METRIC_INVOLUNTARY_SWITCHES,
+    METRIC_PROCESSES,
+    METRIC_COUNT
+} metric_t;
+
+static const struct {
+    const char *name;
+    const char *type;
+    const char *help;
+} metric_families[METRIC_COUNT] = {
+    { "inits_service_cpu_user_seconds_total", "counter",
+      "User CPU time consumed by the service process tree." },
+    { "inits_service_cpu_system_seconds_total", "counter",
+      "System CPU time consumed by the service process tree." },
+    { "inits_service_duration_seconds", "gauge",
+      "Wall-clock time the service script ran before exiting." },
+    { "inits_service_max_rss_bytes", "gauge",
+      "Largest resident set size of any process in the service tree." },
+    { "inits_service_minor_faults_total", "counter",
+      "Minor page faults incurred by the service process tree." },
+    { "inits_service_major_faults_total", "counter",
+      "Major page faults incurred by the service process tree." },
+    { "inits_service_voluntary_context_switches_total", "counter",
+      "Voluntary context switches of the service process tree." },
+    { "inits_service_involuntary_context_switches_total", "counter",
+      "Involuntary context switches of the service process tree." },
+    { "inits_service_processes_total", "counter",
+      "Processes reaped from the service process tree." },
+};
+
+/**
+ * Get the value of a metric for a service
+ */
+static double metric_value(const service_usage_t *service, metric_t metric) {
+    switch (metric) {
+    case METRIC_CPU_USER:
+        return (double)service->utime.tv_sec + (double)service->utime.tv_usec / 1e6;
+    case METRIC_CPU_SYSTEM:
+        return (double)service->stime.tv_sec + (double)service->stime.tv_usec / 1e6;
+    case METRIC_WALL:
+        return service->wall_seconds;
+    case METRIC_MAX_RSS:
+        return (double)service->maxrss * 1024.0;
+    case METRIC_MINOR_FAULTS:
+        return (double)service->minflt;
+    case METRIC_MAJOR_FAULTS:
+        return (double)service->majflt;
+    case METRIC_VOLUNTARY_SWITCHES:
+        return (double)service->nvcsw;
+    case METRIC_INVOLUNTARY_SWITCHES:
+        return (double)service->nivcsw;
+    case METRIC_PROCESSES:
+        return (double)service->processes;
+    default:
+        return 0.0;
+    }
+}
+
+/**
+ * Write a label value with Prometheus escaping
+ */
+static void write_label_value(FILE *out, const char *value) {
+    for (const char *p = value; *p != '\0'; p++) {
+        if (*p == '\\' || *p == '"') {
+            fputc('\\', out);
+            fputc(*p, out);
+        } else if (*p == '\n') {
+            fputs("\\n", out);
+        } else {
+            fputc(*p, out);
+        }
+    }
+}
+
+int reaper_export_metrics(void) {
+    const char *path = getenv("INITS_METRICS_FILE");
+    char tmp_path[512];
+    FILE *out;
+
+    if (path == NULL) {
+        path = INITS_METRICS_FILE;
+    }
+    if (path[0] == '\0') {
+        return 0;
+    }
+
+    /* Write to a temporary file so the collector never sees a partial file */
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    out = fopen(tmp_path, "w");
+    if (out == NULL) {
+        log_message("[WARN] Failed to open metrics file %s", tmp_path);
+        return -1;
+    }
+
+    for (int m = 0; m < METRIC_COUNT; m++) {
+        fprintf(out, "# HELP %s %s\n", metric_families[m].name, metric_families[m].help);
+        fprintf(out, "# TYPE %s %s\n", metric_families[m].name, metric_families[m].type);
+        for (size_t i = 0; i < usage_count; i++) {
+            fprintf(out, "%s{service=\"", metric_families[m].name);
+            write_label_value(out, usage[i].name);
+            fprintf(out, "\",runlevel=\"%d\"} %.15g\n", current_runlevel,
+                    metric_value(&usage[i], (metric_t)m));
+        }
+    }
+
+    if (fclose(out) != 0 || rename(tmp_path, path) < 0) {
+        log_message("[WARN] Failed to write metrics file %s", path);
+        unlink(tmp_path);
+        return -1;
+    }
+
+    log_message("[INFO] Exported resource usage of %zu service(s) to %s",
+               usage_count, path);
+    return 0;
+}
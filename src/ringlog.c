@@ -0,0 +1,210 @@
+/*
+ * inits - A lightweight UNIX init system
+ * Copyright (C) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "ringlog.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*
+ * The ring is shared between processes (forked workers and readers), so
+ * sequence numbers are claimed and published with atomic operations
+ */
+#if defined(__GNUC__)
+#define RING_LOAD(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define RING_STORE(ptr, value) __atomic_store_n((ptr), (value), __ATOMIC_RELEASE)
+#define RING_CLAIM(ptr) __atomic_fetch_add((ptr), 1, __ATOMIC_RELAXED)
+#else
+#define RING_LOAD(ptr) (*(volatile uint64_t *)(ptr))
+#define RING_STORE(ptr, value) (*(volatile uint64_t *)(ptr) = (value))
+#define RING_CLAIM(ptr) ((*(volatile uint64_t *)(ptr))++)
+#endif
+
+static const char *level_names[] = { "INFO", "WARN", "ERROR", "FATAL" };
+
+/**
+ * Check whether a mapped header describes a usable ring of file_size bytes
+ */
+static int header_valid(const ringlog_header_t *header, size_t file_size) {
+    return header->magic == RINGLOG_MAGIC &&
+           header->version == RINGLOG_VERSION &&
+           header->record_size == RINGLOG_RECORD_SIZE &&
+           header->record_count > 0 &&
+           (size_t)(header->record_count + 1) * RINGLOG_RECORD_SIZE <= file_size;
+}
+
+int ringlog_open(ringlog_t *ring, const char *path, size_t size, int writable) {
+    struct stat st;
+    size_t map_size;
+    void *map;
+    int fd;
+
+    memset(ring, 0, sizeof(*ring));
+
+    fd = open(path, writable ? O_RDWR | O_CREAT : O_RDONLY, 0640);
+    if (fd < 0) {
+        return -1;
+    }
+
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    map_size = (size_t)st.st_size;
+    if (writable && map_size < 2 * RINGLOG_RECORD_SIZE) {
+        /* New or truncated file: size it for the requested capacity */
+        if (size < 2 * RINGLOG_RECORD_SIZE) {
+            size = 2 * RINGLOG_RECORD_SIZE;
+        }
+        map_size = size - size % RINGLOG_RECORD_SIZE;
+        if (ftruncate(fd, (off_t)map_size) < 0) {
+            close(fd);
+            return -1;
+        }
+    } else if (map_size < 2 * RINGLOG_RECORD_SIZE) {
+        close(fd);
+        return -1;
+    }
+
+    map = mmap(NULL, map_size, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+               MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return -1;
+    }
+
+    ring->header = map;
+    ring->records = (ringlog_record_t *)((char *)map + RINGLOG_RECORD_SIZE);
+    ring->map_size = map_size;
+
+    if (!header_valid(ring->header, map_size)) {
+        if (!writable) {
+            ringlog_close(ring);
+            return -1;
+        }
+
+        /* Not a ring (or an incompatible one): start over */
+        memset(map, 0, map_size);
+        ring->header->magic = RINGLOG_MAGIC;
+        ring->header->version = RINGLOG_VERSION;
+        ring->header->record_size = RINGLOG_RECORD_SIZE;
+        ring->header->record_count = (uint32_t)(map_size / RINGLOG_RECORD_SIZE - 1);
+        ring->header->next_seq = 1;
+    }
+
+    return 0;
+}
+
+void ringlog_close(ringlog_t *ring) {
+    if (ring->header != NULL) {
+        munmap(ring->header, ring->map_size);
+    }
+    memset(ring, 0, sizeof(*ring));
+}
+
+void ringlog_write(ringlog_t *ring, int level, int event, uint32_t service_id,
+                   int32_t status, const char *payload, size_t length) {
+    struct timespec now;
+    ringlog_record_t *record;
+    uint64_t seq;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    seq = RING_CLAIM(&ring->header->next_seq);
+    record = &ring->records[(seq - 1) % ring->header->record_count];
+
+    /* Mark the slot as in progress before touching its contents */
+    RING_STORE(&record->seq, 0);
+
+    if (length > RINGLOG_PAYLOAD_SIZE) {
+        length = RINGLOG_PAYLOAD_SIZE;
+    }
+    record->timestamp_ns = (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+    record->service_id = service_id;
+    record->status = status;
+    record->level = (uint8_t)level;
+    record->event = (uint8_t)event;
+    record->length = (uint16_t)length;
+    memcpy(record->payload, payload, length);
+
+    RING_STORE(&record->seq, seq);
+}
+
+uint64_t ringlog_next_seq(const ringlog_t *ring) {
+    return RING_LOAD(&ring->header->next_seq);
+}
+
+uint64_t ringlog_oldest_seq(const ringlog_t *ring) {
+    uint64_t next = ringlog_next_seq(ring);
+    uint32_t count = ring->header->record_count;
+
+    return next > count ? next - count : 1;
+}
+
+int ringlog_read(const ringlog_t *ring, uint64_t seq, ringlog_record_t *record) {
+    const ringlog_record_t *slot = &ring->records[(seq - 1) % ring->header->record_count];
+    uint64_t before = RING_LOAD(&slot->seq);
+
+    if (before != seq) {
+        return before > seq ? -1 : 0;
+    }
+
+    memcpy(record, slot, sizeof(*record));
+
+    /* A writer may have reused the slot while we copied it */
+    if (RING_LOAD(&slot->seq) != seq) {
+        return -1;
+    }
+    record->seq = seq;
+    return 1;
+}
+
+uint32_t ringlog_service_id(const char *name) {
+    /* 32-bit FNV-1a */
+    uint32_t hash = 2166136261u;
+
+    for (const unsigned char *p = (const unsigned char *)name; *p != '\0'; p++) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return hash != 0 ? hash : 1;
+}
+
+const char *ringlog_level_name(int level) {
+    if (level < 0 || level > RINGLOG_LEVEL_FATAL) {
+        return "?";
+    }
+    return level_names[level];
+}
+
+int ringlog_parse_level(const char *name, size_t length) {
+    for (int level = 0; level <= RINGLOG_LEVEL_FATAL; level++) {
+        if (strlen(level_names[level]) == length &&
+            strncmp(level_names[level], name, length) == 0) {
+            return level;
+        }
+    }
+    return -1;
+}
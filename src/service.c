@@ -20,6 +20,9 @@
 
 #include "service.h"
 #include "logging.h"
+#include "reaper.h"
+#include "instance.h"
+#include "unmount.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -34,6 +37,33 @@
 #define INITS_DIR "/etc/inits.d"
 #endif
 #define INITIAL_CAPACITY 16
+#define MAX_FIXED_INSTANCES 4096
+#define MAX_DIRECTIVE_LINES 32
+#define DIRECTIVE_PREFIX "inits:"
+#ifndef UNMOUNT_DEADLINE
+#define UNMOUNT_DEADLINE 30
+#endif
+
+/**
+ * Get the service script directory, honouring the INITS_DIR override
+ */
+static const char *services_dir(void) {
+    const char *dir = getenv("INITS_DIR");
+    return (dir != NULL && dir[0] != '\0') ? dir : INITS_DIR;
+}
+
+/**
+ * Get the unmount stage deadline, honouring INITS_UNMOUNT_DEADLINE
+ * Returns the deadline in seconds; 0 disables the unmount stage
+ */
+static unsigned int unmount_deadline(void) {
+    const char *deadline = getenv("INITS_UNMOUNT_DEADLINE");
+    
+    if (deadline == NULL || deadline[0] == '\0' || !isdigit(deadline[0])) {
+        return UNMOUNT_DEADLINE;
+    }
+    return (unsigned int)atoi(deadline);
+}
 
 /**
  * Initialize an empty service list
@@ -73,12 +103,17 @@ static int add_service(service_list_t *services, const service_info_t *service)
 /**
  * Parse a service filename to extract runlevel and ordering information
  * Handles both single-runlevel (e.g., "3a-service") and multi-runlevel (e.g., "3a1b-service")
+ * A trailing "@spec" on the name marks a template (e.g., "3d-worker@cpu")
  * Returns 1 if the service matches the given runlevel, 0 otherwise, -1 on error
  */
 int parse_service_filename(const char *filename, int runlevel, service_info_t *info) {
     const char *p = filename;
+    const char *template_spec;
     int found_runlevel = 0;
     char ordering_prefix[64] = {0};
+    size_t name_len;
+    instance_mode_t instance_mode = INSTANCE_NONE;
+    int instance_count = 0;
     
     /* Parse runlevel-ordering pairs until we hit a dash */
     while (*p != '\0' && *p != '-') {
@@ -125,20 +160,62 @@ int parse_service_filename(const char *filename, int runlevel, service_info_t *i
         return -1; /* No name after dash */
     }
     
+    /* A trailing "@spec" makes this a template for several instances */
+    name_len = strlen(p);
+    template_spec = strchr(p, '@');
+    if (template_spec != NULL) {
+        const char *spec = template_spec + 1;
+        
+        name_len = template_spec - p;
+        if (name_len == 0) {
+            return -1; /* No name before '@' */
+        }
+        
+        if (*spec == '\0') {
+            instance_mode = INSTANCE_CPUS;
+        } else if (strcmp(spec, "cpu") == 0) {
+            instance_mode = INSTANCE_CPU_PINNED;
+        } else if (strcmp(spec, "node") == 0) {
+            instance_mode = INSTANCE_NODE_PINNED;
+        } else {
+            /* Fixed instance count: digits only, no sign or whitespace */
+            for (const char *d = spec; *d != '\0'; d++) {
+                if (!isdigit(*d)) {
+                    return -1;
+                }
+            }
+            if (strlen(spec) > 4) {
+                return -1;
+            }
+            instance_count = atoi(spec);
+            if (instance_count < 1 || instance_count > MAX_FIXED_INSTANCES) {
+                return -1;
+            }
+            instance_mode = INSTANCE_FIXED;
+        }
+    }
+    
     /* If this service matches our runlevel, populate the info structure */
     if (found_runlevel) {
         strncpy(info->filename, filename, sizeof(info->filename) - 1);
         info->filename[sizeof(info->filename) - 1] = '\0';
         
-        strncpy(info->name, p, sizeof(info->name) - 1);
-        info->name[sizeof(info->name) - 1] = '\0';
+        if (name_len >= sizeof(info->name)) {
+            name_len = sizeof(info->name) - 1;
+        }
+        memcpy(info->name, p, name_len);
+        info->name[name_len] = '\0';
         
         strncpy(info->ordering_prefix, ordering_prefix, sizeof(info->ordering_prefix) - 1);
         info->ordering_prefix[sizeof(info->ordering_prefix) - 1] = '\0';
         
         info->runlevel = runlevel;
+        info->instance_mode = instance_mode;
+        info->instance_count = instance_count;
+        info->instance = -1;
+        info->trigger_count = 0;
         
-        snprintf(info->full_path, sizeof(info->full_path), "%s/%s", INITS_DIR, filename);
+        snprintf(info->full_path, sizeof(info->full_path), "%s/%s", services_dir(), filename);
         
         return 1;
     }
@@ -146,14 +223,142 @@ int parse_service_filename(const char *filename, int runlevel, service_info_t *i
     return 0;
 }
 
+/**
+ * Parse the arguments of a "trigger" directive: "<type> <absolute path>"
+ * Returns 0 on success, -1 on failure
+ */
+static int parse_trigger(const char *args, service_info_t *info) {
+    service_trigger_t *trigger;
+    char type[16];
+    char path[256];
+    
+    if (info->trigger_count >= MAX_TRIGGERS) {
+        return -1;
+    }
+    
+    if (sscanf(args, "%15s %255s", type, path) != 2 || path[0] != '/') {
+        return -1;
+    }
+    
+    trigger = &info->triggers[info->trigger_count];
+    if (strcmp(type, "exists") == 0) {
+        trigger->type = TRIGGER_EXISTS;
+    } else if (strcmp(type, "nonempty") == 0) {
+        trigger->type = TRIGGER_NONEMPTY;
+    } else if (strcmp(type, "modified") == 0) {
+        trigger->type = TRIGGER_MODIFIED;
+    } else {
+        return -1;
+    }
+    
+    strncpy(trigger->path, path, sizeof(trigger->path) - 1);
+    trigger->path[sizeof(trigger->path) - 1] = '\0';
+    info->trigger_count++;
+    return 0;
+}
+
+/**
+ * Read the "# inits: ..." directives from a script's leading comment block
+ * Returns 0 on success, -1 if the script cannot be read or has a bad directive
+ */
+static int read_service_directives(service_info_t *info) {
+    FILE *script;
+    char line[512];
+    int result = 0;
+    
+    script = fopen(info->full_path, "r");
+    if (script == NULL) {
+        return -1;
+    }
+    
+    for (int n = 0; n < MAX_DIRECTIVE_LINES && fgets(line, sizeof(line), script) != NULL; n++) {
+        char *p = line;
+        
+        /* Directives live in the comment block at the top of the script */
+        if (*p != '#') {
+            while (isspace((unsigned char)*p)) {
+                p++;
+            }
+            if (*p == '\0') {
+                continue;
+            }
+            break;
+        }
+        
+        p++;
+        while (*p == ' ' || *p == '\t') {
+            p++;
+        }
+        if (strncmp(p, DIRECTIVE_PREFIX, strlen(DIRECTIVE_PREFIX)) != 0) {
+            continue;
+        }
+        p += strlen(DIRECTIVE_PREFIX);
+        while (*p == ' ' || *p == '\t') {
+            p++;
+        }
+        
+        if (strncmp(p, "trigger", 7) == 0 && isspace((unsigned char)p[7])) {
+            if (parse_trigger(p + 7, info) < 0) {
+                result = -1;
+            }
+        } else {
+            result = -1; /* Unknown directive */
+        }
+    }
+    
+    fclose(script);
+    return result;
+}
+
 /**
  * Comparator function for qsort - sorts by ordering prefix lexicographically
+ * Ties are broken by filename and instance so template instances stay adjacent
  */
 static int service_comparator(const void *a, const void *b) {
     const service_info_t *service_a = (const service_info_t *)a;
     const service_info_t *service_b = (const service_info_t *)b;
+    int result;
     
-    return strcmp(service_a->ordering_prefix, service_b->ordering_prefix);
+    result = strcmp(service_a->ordering_prefix, service_b->ordering_prefix);
+    if (result == 0) {
+        result = strcmp(service_a->filename, service_b->filename);
+    }
+    if (result == 0) {
+        result = (service_a->instance > service_b->instance) -
+                 (service_a->instance < service_b->instance);
+    }
+    return result;
+}
+
+/**
+ * Expand a templated service into its instances and add them to the list
+ * Each instance is named "<name>@<index>"
+ */
+static int add_instances(service_list_t *services, const service_info_t *template_info) {
+    int total = instance_total(template_info);
+    
+    if (total < 1) {
+        log_message("[ERROR] Failed to determine instance count for %s",
+                   template_info->filename);
+        return -1;
+    }
+    
+    for (int i = 0; i < total; i++) {
+        service_info_t instance = *template_info;
+        
+        instance.instance = i;
+        instance.instance_count = total;
+        snprintf(instance.name, sizeof(instance.name), "%.240s@%d",
+                 template_info->name, i);
+        
+        if (add_service(services, &instance) < 0) {
+            return -1;
+        }
+    }
+    
+    log_message("[INFO] Discovered service template: %s (ordering: %s, %d instance(s))",
+               template_info->name, template_info->ordering_prefix, total);
+    return 0;
 }
 
 /**
@@ -168,7 +373,7 @@ void sort_services(service_list_t *services) {
 
 /**
  * Discover all service scripts for the given runlevel
- * Scans /etc/inits.d directory and filters by runlevel
+ * Scans $INITS_DIR (default /etc/inits.d) and filters by runlevel
  * Returns 0 on success, -1 on failure
  */
 int discover_services(int runlevel, service_list_t *services) {
@@ -181,9 +386,9 @@ int discover_services(int runlevel, service_list_t *services) {
     }
     
     /* Open the directory */
-    dir = opendir(INITS_DIR);
+    dir = opendir(services_dir());
     if (dir == NULL) {
-        log_message("[ERROR] Failed to open directory %s", INITS_DIR);
+        log_message("[ERROR] Failed to open directory %s", services_dir());
         free(services->services);
         services->services = NULL;
         return -1;
@@ -202,7 +407,20 @@ int discover_services(int runlevel, service_list_t *services) {
         /* Parse the filename */
         result = parse_service_filename(entry->d_name, runlevel, &info);
         
-        if (result == 1) {
+        /* Pick up activation triggers and other per-script directives */
+        if (result == 1 && read_service_directives(&info) < 0) {
+            log_message("[WARN] Invalid or unreadable directives in service %s",
+                       info.filename);
+        }
+        
+        if (result == 1 && info.instance_mode != INSTANCE_NONE) {
+            /* Template matches our runlevel, add one entry per instance */
+            if (add_instances(services, &info) < 0) {
+                closedir(dir);
+                free_service_list(services);
+                return -1;
+            }
+        } else if (result == 1) {
             /* Service matches our runlevel, add it to the list */
             if (add_service(services, &info) < 0) {
                 closedir(dir);
@@ -262,6 +480,12 @@ int execute_service(const service_info_t *service) {
     } else if (pid == 0) {
         /* Child process - execute the service script */
         
+        /* Template instances get their index and optional CPU/node pinning */
+        if (service->instance >= 0 && instance_setup(service) < 0) {
+            fprintf(stderr, "[WARN] Failed to pin service %s, running unpinned\n",
+                    service->name);
+        }
+        
         /* Execute the service script with sh */
         /* The RUNLEVEL environment variable is already set and will be inherited */
         execl("/bin/sh", "sh", service->full_path, (char *)NULL);
@@ -272,23 +496,26 @@ int execute_service(const service_info_t *service) {
         exit(127); /* Exit with standard "command not found" status */
     }
     
-    /* Parent process - return the child PID */
+    /* Parent process - track the child and return its PID */
+    if (reaper_track(pid, service->name) < 0) {
+        log_message("[WARN] Failed to track process %d for service %s",
+                   (int)pid, service->name);
+    }
+    
     return pid;
 }
 
 /**
  * Wait for a service to complete
  * Waits for the child process to finish and captures exit status
+ * Descendants reparented to inits are reaped and accounted meanwhile
  * Returns 0 on success, -1 on failure
  */
 int wait_for_service(int pid, int *exit_status) {
     int status;
-    pid_t result;
-    
-    /* Wait for the child process to complete */
-    result = waitpid(pid, &status, 0);
     
-    if (result < 0) {
+    /* Wait for the child process to complete, reaping any adopted descendants */
+    if (reaper_wait(pid, &status) < 0) {
         log_message("[ERROR] Failed to wait for process %d", pid);
         return -1;
     }
@@ -330,10 +557,14 @@ static int send_signal_to_all(int signal) {
 /**
  * Perform system shutdown sequence
  * Sends SIGTERM to all processes, waits 10 seconds,
- * then sends SIGKILL to remaining processes, waits 15 seconds
+ * then sends SIGKILL to remaining processes, waits 15 seconds,
+ * then syncs and unmounts all filesystems
  * Returns 0 on success, -1 on failure
  */
 int shutdown_system(void) {
+    unsigned int deadline = unmount_deadline();
+    int result = 0;
+    
     log_message("[INFO] Initiating system shutdown sequence");
     
     /* Send SIGTERM to all processes */
@@ -344,7 +575,7 @@ int shutdown_system(void) {
     
     /* Wait 10 seconds for processes to terminate gracefully */
     log_message("[INFO] Waiting 10 seconds for processes to terminate");
-    sleep(10);
+    reaper_drain(10);
     
     /* Send SIGKILL to remaining processes */
     if (send_signal_to_all(SIGKILL) < 0) {
@@ -354,10 +585,24 @@ int shutdown_system(void) {
     
     /* Wait 15 seconds for processes to be killed */
     log_message("[INFO] Waiting 15 seconds for remaining processes");
-    sleep(15);
+    reaper_drain(15);
+    
+    /* Continue shutdown regardless of remaining processes, recording its cost
+     * while /var is still writable */
+    reaper_export_metrics();
+    
+    /* Release the log file so its filesystem can be unmounted; later messages go to stderr */
+    close_logging();
+    
+    /* Flush and release every filesystem before handing back to the caller */
+    if (deadline == 0) {
+        log_message("[INFO] Unmount stage disabled, skipping");
+    } else if (unmount_filesystems(deadline) < 0) {
+        log_message("[WARN] Some filesystems could not be unmounted or made read-only");
+        result = -1;
+    }
     
-    /* Continue shutdown regardless of remaining processes */
     log_message("[INFO] Shutdown sequence complete");
     
-    return 0;
+    return result;
 }
@@ -0,0 +1,351 @@
+/*
+ * inits - A lightweight UNIX init system
+ * Copyright (C) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "trigger.h"
+#include "logging.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
+#define WAKEUP_INTERVAL_MS 1000 /* Recheck the stop flag at least this often */
+
+#ifdef __linux__
+/* Directories only matter when entries appear; files when they change */
+#define DIR_WATCH_MASK (IN_CREATE | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF)
+#define FILE_WATCH_MASK (IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | \
+                         IN_DELETE_SELF | IN_MOVE_SELF)
+#endif
+
+/**
+ * State of a "modified" trigger path when the triggers were armed
+ */
+typedef struct {
+    int existed;                  /* Path existed */
+    struct timespec mtime;        /* Modification time */
+    ino_t inode;                  /* Inode, to notice replacement by rename */
+    off_t size;                   /* File size */
+} trigger_baseline_t;
+
+static int *pending = NULL;                   /* Per service: still waiting */
+static trigger_baseline_t *baselines = NULL;  /* Per service and trigger */
+static size_t service_count = 0;
+
+#ifdef __linux__
+static int inotify_fd = -1;
+static int *watches = NULL;
+static size_t watch_count = 0;
+static size_t watch_capacity = 0;
+#endif
+
+/**
+ * Check whether a directory has any entry besides . and ..
+ */
+static int directory_nonempty(const char *path) {
+    DIR *dir = opendir(path);
+    struct dirent *entry;
+    int nonempty = 0;
+
+    if (dir == NULL) {
+        return 0;
+    }
+
+    while ((entry = readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+            nonempty = 1;
+            break;
+        }
+    }
+
+    closedir(dir);
+    return nonempty;
+}
+
+/**
+ * Evaluate a trigger against the current filesystem state
+ */
+static int trigger_fired(const service_trigger_t *trigger, const trigger_baseline_t *baseline) {
+    struct stat st;
+
+    if (stat(trigger->path, &st) < 0) {
+        return 0;
+    }
+
+    switch (trigger->type) {
+    case TRIGGER_EXISTS:
+        return 1;
+    case TRIGGER_NONEMPTY:
+        return S_ISDIR(st.st_mode) && directory_nonempty(trigger->path);
+    case TRIGGER_MODIFIED:
+        return !baseline->existed ||
+               st.st_ino != baseline->inode ||
+               st.st_size != baseline->size ||
+               st.st_mtim.tv_sec != baseline->mtime.tv_sec ||
+               st.st_mtim.tv_nsec != baseline->mtime.tv_nsec;
+    default:
+        return 0;
+    }
+}
+
+#ifdef __linux__
+/**
+ * Add an inotify watch on a path and remember its descriptor
+ */
+static void add_watch(const char *path, uint32_t mask) {
+    int wd = inotify_add_watch(inotify_fd, path, mask);
+
+    if (wd < 0) {
+        return;
+    }
+
+    if (watch_count >= watch_capacity) {
+        size_t new_capacity = watch_capacity ? watch_capacity * 2 : 16;
+        int *new_watches = realloc(watches, new_capacity * sizeof(int));
+        if (new_watches == NULL) {
+            inotify_rm_watch(inotify_fd, wd);
+            return;
+        }
+        watches = new_watches;
+        watch_capacity = new_capacity;
+    }
+    watches[watch_count++] = wd;
+}
+
+/**
+ * Watch a path if it exists, otherwise its nearest existing ancestor
+ * Watching the ancestor catches the creation of the next missing component
+ */
+static void watch_path_or_ancestor(const char *path) {
+    char current[256];
+    struct stat st;
+
+    strncpy(current, path, sizeof(current) - 1);
+    current[sizeof(current) - 1] = '\0';
+
+    while (stat(current, &st) < 0) {
+        char *slash = strrchr(current, '/');
+        if (slash == NULL || slash == current) {
+            strcpy(current, "/");
+            stat(current, &st);
+            break;
+        }
+        *slash = '\0';
+    }
+
+    add_watch(current, S_ISDIR(st.st_mode) ? DIR_WATCH_MASK : FILE_WATCH_MASK);
+}
+
+/**
+ * Replace all watches with fresh ones for the pending triggers
+ * Rebuilt on every wakeup so that newly created path components are covered
+ */
+static void rebuild_watches(const service_list_t *services) {
+    for (size_t i = 0; i < watch_count; i++) {
+        inotify_rm_watch(inotify_fd, watches[i]);
+    }
+    watch_count = 0;
+
+    for (size_t i = 0; i < service_count; i++) {
+        const service_info_t *service = &services->services[i];
+
+        if (!pending[i]) {
+            continue;
+        }
+
+        for (int t = 0; t < service->trigger_count; t++) {
+            const service_trigger_t *trigger = &service->triggers[t];
+
+            watch_path_or_ancestor(trigger->path);
+
+            /* Files are often replaced by rename, so watch their directory too */
+            if (trigger->type == TRIGGER_MODIFIED) {
+                char parent[256];
+                char *slash;
+
+                strncpy(parent, trigger->path, sizeof(parent) - 1);
+                parent[sizeof(parent) - 1] = '\0';
+                slash = strrchr(parent, '/');
+                if (slash != NULL && slash != parent) {
+                    *slash = '\0';
+                    watch_path_or_ancestor(parent);
+                }
+            }
+        }
+    }
+}
+#endif
+
+#ifdef __linux__
+/**
+ * Discard all queued inotify events
+ * Only the fact that something happened matters, and removing watches
+ * queues IN_IGNORED events that must not cause a wakeup
+ */
+static void drain_events(void) {
+    char events[4096];
+
+    while (read(inotify_fd, events, sizeof(events)) > 0) {
+        /* Discard */
+    }
+}
+#endif
+
+/**
+ * Block until something may have changed, or the wakeup interval passes
+ */
+static void wait_for_change(void) {
+#ifdef __linux__
+    struct pollfd pfd;
+
+    pfd.fd = inotify_fd;
+    pfd.events = POLLIN;
+    poll(&pfd, 1, WAKEUP_INTERVAL_MS);
+#else
+    /* Without inotify, fall back to polling the trigger paths */
+    const struct timespec interval = { WAKEUP_INTERVAL_MS / 1000, 0 };
+    nanosleep(&interval, NULL);
+#endif
+}
+
+long trigger_arm(const service_list_t *services) {
+    long count = 0;
+
+    trigger_cleanup();
+
+    service_count = services->count;
+    pending = calloc(service_count ? service_count : 1, sizeof(int));
+    baselines = calloc(service_count ? service_count * MAX_TRIGGERS : 1,
+                       sizeof(trigger_baseline_t));
+    if (pending == NULL || baselines == NULL) {
+        log_message("[ERROR] Failed to allocate memory for service triggers");
+        trigger_cleanup();
+        return -1;
+    }
+
+    for (size_t i = 0; i < service_count; i++) {
+        const service_info_t *service = &services->services[i];
+
+        if (service->trigger_count == 0) {
+            continue;
+        }
+
+        for (int t = 0; t < service->trigger_count; t++) {
+            trigger_baseline_t *baseline = &baselines[i * MAX_TRIGGERS + t];
+            struct stat st;
+
+            if (stat(service->triggers[t].path, &st) == 0) {
+                baseline->existed = 1;
+                baseline->mtime = st.st_mtim;
+                baseline->inode = st.st_ino;
+                baseline->size = st.st_size;
+            }
+        }
+
+        pending[i] = 1;
+        count++;
+    }
+
+#ifdef __linux__
+    if (count > 0) {
+        inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotify_fd < 0) {
+            log_message("[ERROR] Failed to initialize inotify: %s", strerror(errno));
+            trigger_cleanup();
+            return -1;
+        }
+    }
+#endif
+
+    return count;
+}
+
+long trigger_wait(const service_list_t *services, volatile sig_atomic_t *stop) {
+    while (!*stop) {
+        int any_pending = 0;
+
+#ifdef __linux__
+        /* Arm before checking, so no change between the two is missed */
+        rebuild_watches(services);
+        drain_events();
+#endif
+
+        for (size_t i = 0; i < service_count; i++) {
+            const service_info_t *service = &services->services[i];
+
+            if (!pending[i]) {
+                continue;
+            }
+            any_pending = 1;
+
+            for (int t = 0; t < service->trigger_count; t++) {
+                if (!trigger_fired(&service->triggers[t], &baselines[i * MAX_TRIGGERS + t])) {
+                    continue;
+                }
+
+                log_message("[INFO] Trigger fired for service %s: %s",
+                           service->name, service->triggers[t].path);
+
+                /* Release every instance of the same script together */
+                for (size_t j = i; j < service_count &&
+                     strcmp(services->services[j].filename, service->filename) == 0; j++) {
+                    pending[j] = 0;
+                }
+                return (long)i;
+            }
+        }
+
+        if (!any_pending) {
+            return -1;
+        }
+
+        wait_for_change();
+    }
+
+    return -1;
+}
+
+void trigger_cleanup(void) {
+#ifdef __linux__
+    if (inotify_fd >= 0) {
+        close(inotify_fd);
+        inotify_fd = -1;
+    }
+    free(watches);
+    watches = NULL;
+    watch_count = 0;
+    watch_capacity = 0;
+#endif
+
+    free(pending);
+    pending = NULL;
+    free(baselines);
+    baselines = NULL;
+    service_count = 0;
+}
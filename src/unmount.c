@@ -0,0 +1,430 @@
+/*
+ * inits - A lightweight UNIX init system
+ * Copyright (C) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE /* syncfs() and umount2() */
+
+#include "unmount.h"
+#include "logging.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#ifdef __linux__
+#include <sys/mount.h>
+#endif
+
+#define MOUNTINFO_PATH "/proc/self/mountinfo"
+#define INITIAL_CAPACITY 16
+#define MAX_UNMOUNT_WORKERS 16
+#define POLL_INTERVAL_NS 10000000L /* 10ms between worker status checks */
+
+#ifdef __linux__
+/**
+ * A single entry of /proc/self/mountinfo
+ */
+typedef struct {
+    int id;                       /* Mount ID */
+    int parent_id;                /* Parent mount ID */
+    char path[512];               /* Mount point */
+    char fstype[64];              /* Filesystem type */
+    int depth;                    /* Distance from the root mount */
+    int subtree;                  /* Index of the top-level mount it lives under */
+} mount_entry_t;
+
+/**
+ * Kernel and virtual filesystems that are left mounted
+ */
+static const char *api_filesystems[] = {
+    "proc", "sysfs", "devtmpfs", "devpts", "cgroup", "cgroup2", "securityfs",
+    "debugfs", "tracefs", "pstore", "bpf", "mqueue", "hugetlbfs", "configfs",
+    "fusectl", "efivarfs", "binfmt_misc", "autofs", "rpc_pipefs", "selinuxfs",
+    NULL
+};
+
+/**
+ * Get milliseconds elapsed since start
+ */
+static long elapsed_ms(const struct timespec *start) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long)(now.tv_sec - start->tv_sec) * 1000 +
+           (now.tv_nsec - start->tv_nsec) / 1000000;
+}
+
+/**
+ * Decode the octal escapes (\040 etc.) used for mount points in mountinfo
+ */
+static void unescape_path(char *path) {
+    char *in = path;
+    char *out = path;
+
+    while (*in != '\0') {
+        if (in[0] == '\\' && in[1] >= '0' && in[1] <= '7' &&
+            in[2] >= '0' && in[2] <= '7' && in[3] >= '0' && in[3] <= '7') {
+            *out++ = (char)((in[1] - '0') * 64 + (in[2] - '0') * 8 + (in[3] - '0'));
+            in += 4;
+        } else {
+            *out++ = *in++;
+        }
+    }
+    *out = '\0';
+}
+
+/**
+ * Check whether a filesystem type is a kernel API filesystem
+ */
+static int is_api_filesystem(const char *fstype) {
+    for (int i = 0; api_filesystems[i] != NULL; i++) {
+        if (strcmp(fstype, api_filesystems[i]) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Read the mount table
+ * Returns the number of entries on success, -1 on failure
+ */
+static long read_mounts(mount_entry_t **mounts) {
+    FILE *file = fopen(MOUNTINFO_PATH, "r");
+    mount_entry_t *entries = NULL;
+    size_t count = 0;
+    size_t capacity = 0;
+    char line[2048];
+
+    if (file == NULL) {
+        log_message("[ERROR] Failed to open %s", MOUNTINFO_PATH);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), file) != NULL) {
+        mount_entry_t entry;
+        const char *separator;
+
+        memset(&entry, 0, sizeof(entry));
+
+        /* "<id> <parent> <major:minor> <root> <mount point> ..." */
+        if (sscanf(line, "%d %d %*s %*s %511s", &entry.id, &entry.parent_id,
+                   entry.path) != 3) {
+            continue;
+        }
+
+        /* "... - <fstype> <source> <super options>" */
+        separator = strstr(line, " - ");
+        if (separator == NULL || sscanf(separator + 3, "%63s", entry.fstype) != 1) {
+            continue;
+        }
+
+        unescape_path(entry.path);
+
+        if (count >= capacity) {
+            size_t new_capacity = capacity ? capacity * 2 : INITIAL_CAPACITY;
+            mount_entry_t *new_entries = realloc(entries, new_capacity * sizeof(*entries));
+            if (new_entries == NULL) {
+                log_message("[ERROR] Failed to allocate memory for mount table");
+                free(entries);
+                fclose(file);
+                return -1;
+            }
+            entries = new_entries;
+            capacity = new_capacity;
+        }
+        entries[count++] = entry;
+    }
+
+    fclose(file);
+    *mounts = entries;
+    return (long)count;
+}
+
+/**
+ * Find a mount by ID
+ * Returns the index, or -1 if there is no such mount
+ */
+static long find_mount(const mount_entry_t *mounts, size_t count, int id) {
+    for (size_t i = 0; i < count; i++) {
+        if (mounts[i].id == id) {
+            return (long)i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Assign every mount its depth and the top-level subtree it belongs to
+ * Mounts outside the root mount, and mounts on or below kernel API
+ * filesystems, get a subtree of -1 and are left alone
+ */
+static void build_mount_tree(mount_entry_t *mounts, size_t count, size_t root) {
+    for (size_t i = 0; i < count; i++) {
+        long current = (long)i;
+        int skip = 0;
+
+        mounts[i].depth = 0;
+        mounts[i].subtree = -1;
+
+        if (i == root) {
+            continue;
+        }
+
+        /* Walk up to the root mount, remembering the last mount before it */
+        while (current >= 0 && (size_t)current != root) {
+            if (is_api_filesystem(mounts[current].fstype)) {
+                skip = 1;
+            }
+            mounts[i].subtree = (int)current;
+            mounts[i].depth++;
+            current = find_mount(mounts, count, mounts[current].parent_id);
+
+            /* Guard against malformed tables with parent cycles */
+            if (mounts[i].depth > (int)count) {
+                current = -1;
+            }
+        }
+
+        if (current < 0 || skip) {
+            mounts[i].subtree = -1;
+        }
+    }
+}
+
+/**
+ * Comparator function for qsort - deepest mounts first
+ */
+static int depth_comparator(const void *a, const void *b) {
+    const mount_entry_t *mount_a = (const mount_entry_t *)a;
+    const mount_entry_t *mount_b = (const mount_entry_t *)b;
+
+    return mount_b->depth - mount_a->depth;
+}
+
+/**
+ * Flush a filesystem given one of its paths
+ */
+static void sync_mount(const char *path) {
+    struct timespec start;
+    int fd;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    fd = open(path, O_RDONLY | O_DIRECTORY);
+    if (fd < 0 || syncfs(fd) < 0) {
+        log_message("[WARN] Failed to sync %s: %s", path, strerror(errno));
+    } else {
+        log_message("[INFO] Synced %s (%ld ms)", path, elapsed_ms(&start));
+    }
+
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+/**
+ * Unmount a filesystem, or remount it read-only if it refuses
+ * Returns 0 on success, -1 if the filesystem is still writable
+ */
+static int release_mount(const char *path) {
+    struct timespec start;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if (umount2(path, 0) == 0) {
+        log_message("[INFO] Unmounted %s (%ld ms)", path, elapsed_ms(&start));
+        return 0;
+    }
+    log_message("[WARN] Failed to unmount %s: %s, remounting read-only",
+               path, strerror(errno));
+
+    if (mount(NULL, path, NULL, MS_REMOUNT | MS_RDONLY, NULL) == 0) {
+        log_message("[INFO] Remounted %s read-only (%ld ms)", path, elapsed_ms(&start));
+        return 0;
+    }
+    log_message("[ERROR] Failed to remount %s read-only: %s", path, strerror(errno));
+    return -1;
+}
+
+/**
+ * Worker process body: release one subtree, deepest mounts first
+ * Returns the process exit status (0 if everything was released)
+ */
+static int release_subtree(const mount_entry_t *mounts, size_t count, int subtree) {
+    mount_entry_t *members = malloc(count * sizeof(*members));
+    size_t member_count = 0;
+    int failures = 0;
+
+    if (members == NULL) {
+        return 1;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (mounts[i].subtree == subtree) {
+            members[member_count++] = mounts[i];
+        }
+    }
+
+    qsort(members, member_count, sizeof(*members), depth_comparator);
+
+    for (size_t i = 0; i < member_count; i++) {
+        sync_mount(members[i].path);
+        if (release_mount(members[i].path) < 0) {
+            failures = 1;
+        }
+    }
+
+    free(members);
+    return failures;
+}
+
+/**
+ * Wait for workers until all are done or the deadline passes
+ * Workers still running at the deadline are killed and counted as failed
+ * Returns the number of failed workers
+ */
+static int wait_for_workers(pid_t *workers, size_t *active, const struct timespec *start,
+                            unsigned int deadline_seconds, size_t keep) {
+    const struct timespec interval = { 0, POLL_INTERVAL_NS };
+    int failures = 0;
+
+    while (*active > keep) {
+        for (size_t i = 0; i < *active; ) {
+            int status;
+
+            if (waitpid(workers[i], &status, WNOHANG) == workers[i]) {
+                if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                    failures++;
+                }
+                workers[i] = workers[--(*active)];
+            } else {
+                i++;
+            }
+        }
+
+        if (*active <= keep) {
+            break;
+        }
+
+        if (elapsed_ms(start) >= (long)deadline_seconds * 1000) {
+            log_message("[ERROR] Unmount deadline of %u seconds exceeded, "
+                        "abandoning %zu worker(s)", deadline_seconds, *active);
+            for (size_t i = 0; i < *active; i++) {
+                kill(workers[i], SIGKILL);
+            }
+            failures += (int)*active;
+            *active = 0;
+            break;
+        }
+
+        nanosleep(&interval, NULL);
+    }
+
+    return failures;
+}
+
+int unmount_filesystems(unsigned int deadline_seconds) {
+    pid_t workers[MAX_UNMOUNT_WORKERS];
+    size_t active = 0;
+    struct timespec start;
+    mount_entry_t *mounts = NULL;
+    long root = -1;
+    long count;
+    int failures = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    log_message("[INFO] Syncing and unmounting filesystems (deadline: %u seconds)",
+               deadline_seconds);
+
+    count = read_mounts(&mounts);
+    if (count < 0) {
+        sync();
+        return -1;
+    }
+
+    /* The last "/" listed is the one on top of any overmounted roots */
+    for (long i = 0; i < count; i++) {
+        if (strcmp(mounts[i].path, "/") == 0) {
+            root = i;
+        }
+    }
+    if (root < 0) {
+        log_message("[ERROR] No root filesystem found in %s", MOUNTINFO_PATH);
+        free(mounts);
+        sync();
+        return -1;
+    }
+
+    build_mount_tree(mounts, (size_t)count, (size_t)root);
+
+    /* One worker per top-level subtree, at most MAX_UNMOUNT_WORKERS at once */
+    for (long i = 0; i < count; i++) {
+        pid_t pid;
+
+        if (mounts[i].subtree != i) {
+            continue;
+        }
+
+        failures += wait_for_workers(workers, &active, &start, deadline_seconds,
+                                     MAX_UNMOUNT_WORKERS - 1);
+
+        pid = fork();
+        if (pid < 0) {
+            /* Release it from here instead */
+            log_message("[WARN] Failed to fork unmount worker for %s", mounts[i].path);
+            failures += release_subtree(mounts, (size_t)count, (int)i);
+        } else if (pid == 0) {
+            _exit(release_subtree(mounts, (size_t)count, (int)i));
+        } else {
+            workers[active++] = pid;
+        }
+    }
+
+    failures += wait_for_workers(workers, &active, &start, deadline_seconds, 0);
+
+    /* Finally make the root filesystem safe */
+    sync_mount("/");
+    if (mount(NULL, "/", NULL, MS_REMOUNT | MS_RDONLY, NULL) == 0) {
+        log_message("[INFO] Remounted / read-only");
+    } else {
+        log_message("[ERROR] Failed to remount / read-only: %s", strerror(errno));
+        failures++;
+    }
+
+    log_message("[INFO] Filesystem shutdown finished in %ld ms with %d failure(s)",
+               elapsed_ms(&start), failures);
+
+    free(mounts);
+    return failures == 0 ? 0 : -1;
+}
+#else
+int unmount_filesystems(unsigned int deadline_seconds) {
+    (void)deadline_seconds;
+
+    /* No portable way to enumerate mounts: flush everything and move on */
+    log_message("[INFO] Syncing filesystems");
+    sync();
+    return 0;
+}
+#endif
@@ -0,0 +1,168 @@
+/*
+ * inits - A lightweight UNIX init system
+ * Copyright (C) 2025
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * inits-log - Reader for the inits binary ring log
+ *
+ * Usage: inits-log [-f] [-s service] [-l level] [file]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "ringlog.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <unistd.h>
+
+#define FOLLOW_INTERVAL_NS 200000000L /* 200ms between polls */
+#define MAX_STALLS 5                  /* Polls to wait for an unfinished record */
+
+/**
+ * Print usage information
+ */
+static void usage(const char *program) {
+    fprintf(stderr, "Usage: %s [-f] [-s service] [-l level] [file]\n", program);
+    fprintf(stderr, "  -f          Follow the log as new records are written\n");
+    fprintf(stderr, "  -s service  Only show records of the named service\n");
+    fprintf(stderr, "  -l level    Only show records at or above INFO, WARN, ERROR or FATAL\n");
+    fprintf(stderr, "  file        Ring file (default: $INITS_LOG_RING or %s)\n",
+            RINGLOG_DEFAULT_PATH);
+}
+
+/**
+ * Print one record in the same wording as the text log
+ */
+static void print_record(const ringlog_record_t *record) {
+    int length = record->length;
+
+    printf("[%5lu.%06lu] [%s] ",
+           (unsigned long)(record->timestamp_ns / 1000000000u),
+           (unsigned long)(record->timestamp_ns % 1000000000u / 1000u),
+           ringlog_level_name(record->level));
+
+    switch (record->event) {
+    case RINGLOG_EVENT_OPEN:
+        printf("Log opened at %.*s\n", length, record->payload);
+        break;
+    case RINGLOG_EVENT_SERVICE_START:
+        printf("Starting service: %.*s\n", length, record->payload);
+        break;
+    case RINGLOG_EVENT_SERVICE_COMPLETE:
+        printf("Service completed %s: %.*s (exit status: %d)\n",
+               record->status == 0 ? "successfully" : "with error",
+               length, record->payload, (int)record->status);
+        break;
+    default:
+        printf("%.*s\n", length, record->payload);
+        break;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const char *path = getenv("INITS_LOG_RING");
+    const char *service = NULL;
+    const struct timespec interval = { 0, FOLLOW_INTERVAL_NS };
+    uint32_t service_id = 0;
+    int min_level = RINGLOG_LEVEL_INFO;
+    int follow = 0;
+    int stalls = 0;
+    ringlog_t ring;
+    uint64_t seq;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "fs:l:h")) != -1) {
+        switch (opt) {
+        case 'f':
+            follow = 1;
+            break;
+        case 's':
+            service = optarg;
+            break;
+        case 'l':
+            for (char *p = optarg; *p != '\0'; p++) {
+                *p = (char)toupper((unsigned char)*p);
+            }
+            min_level = ringlog_parse_level(optarg, strlen(optarg));
+            if (min_level < 0) {
+                fprintf(stderr, "[ERROR] Unknown level: %s\n", optarg);
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (optind < argc) {
+        path = argv[optind];
+    } else if (path == NULL || path[0] == '\0') {
+        path = RINGLOG_DEFAULT_PATH;
+    }
+
+    if (service != NULL) {
+        service_id = ringlog_service_id(service);
+    }
+
+    if (ringlog_open(&ring, path, 0, 0) < 0) {
+        fprintf(stderr, "[ERROR] Failed to open ring log %s\n", path);
+        return 1;
+    }
+
+    seq = ringlog_oldest_seq(&ring);
+    for (;;) {
+        uint64_t next = ringlog_next_seq(&ring);
+
+        while (seq < next) {
+            ringlog_record_t record;
+            int result = ringlog_read(&ring, seq, &record);
+
+            if (result < 0) {
+                /* Fell behind the writer: skip to what is still there */
+                seq = ringlog_oldest_seq(&ring);
+                continue;
+            }
+
+            if (result == 0) {
+                /* Unfinished record: give its writer a few polls to finish */
+                if (follow && ++stalls < MAX_STALLS) {
+                    break;
+                }
+            } else if (record.level >= min_level &&
+                       (service_id == 0 || record.service_id == service_id)) {
+                print_record(&record);
+            }
+
+            stalls = 0;
+            seq++;
+        }
+
+        if (!follow) {
+            break;
+        }
+
+        fflush(stdout);
+        nanosleep(&interval, NULL);
+    }
+
+    ringlog_close(&ring);
+    return 0;
+}